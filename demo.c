@@ -20,6 +20,7 @@ static const char rcsid[] =
     "$Id";
 
 #include "medians_1D.h"
+#include "median_ostat.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -41,8 +42,19 @@ static const char rcsid[] =
 //! Macro to determine an integer's oddness
 #define odd(x) ((x)&1)
 
+//! Number of sorted runs used when none is given
+#define N_RUNS      16
+
+//! Number of point updates used when none is given
+#define N_UPDATES   10000
+
+//! At most this many quickselect re-runs are timed in bench_updates()
+#define N_REQUERIES 20
+
 // Additional required function prototypes
 void bench(int, size_t);
+void bench_runs(int, size_t, int);
+void bench_updates(size_t, int);
 int compare(const void *, const void*);
 void pixel_qsort(pixelvalue *, int);
 pixelvalue median_AHU(pixelvalue *, int);
@@ -213,6 +225,209 @@ void bench(int verbose, size_t array_size)
     return;
 }
 
+/*! \fn void bench_runs(int, size_t, int)
+   \brief Median of pre-sorted runs: copy-then-quick_select vs. median_runs
+
+   The input is split into nruns chunks that are sorted up front (not
+   timed).  The first method concatenates the runs into one buffer and
+   runs quick_select(); the second selects directly on the runs with
+   median_runs(), without copying.
+*/
+void bench_runs(int verbose, size_t array_size, int nruns)
+{
+    int             i;
+    size_t          off;
+    pixelvalue      med[2];
+    pixelvalue  *   array_init,
+                *   array;
+    pixelvalue  **  runs;
+    int         *   lens;
+    clock_t         chrono;
+    double          elapsed;
+
+    srand48(getpid());
+    if (array_size<1) array_size = BIG_NUM;
+    if (nruns<1) nruns = N_RUNS;
+    if ((size_t)nruns > array_size) nruns = array_size;
+
+    if (verbose) {
+        printf("array size: %ld in %d sorted runs\n", (long)array_size, nruns);
+    } else {
+        printf("%ld\t%d\t", (long)array_size, nruns);
+    }
+
+    array_init = malloc(array_size * sizeof(pixelvalue));
+    array      = malloc(array_size * sizeof(pixelvalue));
+    runs       = malloc(nruns * sizeof(pixelvalue *));
+    lens       = malloc(nruns * sizeof(int));
+    if (array_init==NULL || array==NULL || runs==NULL || lens==NULL) {
+        printf("memory allocation failure: aborting\n");
+        return ;
+    }
+
+    for (i=0 ; i<array_size; i++) {
+        array_init[i] = (pixelvalue)(lrand48() % MAX_ARRAY_VALUE);
+    }
+    for (i=0, off=0 ; i<nruns ; i++) {
+        lens[i] = array_size / nruns + ((size_t)i < array_size % nruns);
+        runs[i] = array_init + off;
+        qsort(runs[i], lens[i], sizeof(pixelvalue), compare);
+        off += lens[i];
+    }
+
+    //! benchmark copying the runs and running quickselect
+    if (verbose) {
+        printf("copy + QS       :\t");
+        fflush(stdout);
+    }
+    chrono = clock();
+    for (i=0, off=0 ; i<nruns ; i++) {
+        memcpy(array + off, runs[i], lens[i] * sizeof(pixelvalue));
+        off += lens[i];
+    }
+    med[0] = quick_select(array, array_size);
+    elapsed = (double)(clock() - chrono) / (double)CLOCKS_PER_SEC;
+    if (verbose) {
+        printf("%5.3f sec\t", elapsed);
+        printf("med %g\n", (double)med[0]);
+    } else {
+        printf("%5.3f\t", elapsed);
+    }
+    fflush(stdout);
+
+    //! benchmark selection directly on the sorted runs
+    if (verbose) {
+        printf("median_runs     :\t");
+        fflush(stdout);
+    }
+    chrono = clock();
+    if (median_runs(runs, lens, nruns, &med[1]) != 0) {
+        printf("median_runs failure: aborting\n");
+        return ;
+    }
+    elapsed = (double)(clock() - chrono) / (double)CLOCKS_PER_SEC;
+    if (verbose) {
+        printf("%5.6f sec\t", elapsed);
+        printf("med %g\n", (double)med[1]);
+    } else {
+        printf("%5.6f\t", elapsed);
+    }
+    fflush(stdout);
+
+    free(lens);
+    free(runs);
+    free(array);
+    free(array_init);
+
+    if (fabs(med[0] - med[1]) > 10 * FLT_EPSILON) {
+        printf("diverging median values!\n");
+    }
+    printf("\n");
+    fflush(stdout);
+    return;
+}
+
+/*! \fn void bench_updates(size_t, int)
+   \brief Point update + median query: order-statistics tree vs. quickselect
+
+   The array is bulk-loaded into an ostat container, then each step
+   changes one random element and asks for the median again.  The
+   updates are drawn up front and the whole update loop is timed as
+   one interval, so the per-query figure carries no timer overhead.
+   The baseline then replays the first N_REQUERIES updates, re-copying
+   the array and re-running quick_select() for each, and every replayed
+   step is checked against the median the container gave.
+*/
+void bench_updates(size_t array_size, int nupdates)
+{
+    int             i, nq;
+    int         *   idx;
+    pixelvalue      last, med[N_REQUERIES], qs[N_REQUERIES];
+    pixelvalue  *   val,
+                *   array_init,
+                *   array;
+    ostat       *   os;
+    clock_t         chrono;
+    double          elapsed, t_tree, t_qs;
+
+    srand48(getpid());
+    if (array_size<1) array_size = BIG_NUM;
+    if (nupdates<1) nupdates = N_UPDATES;
+    nq = (nupdates < N_REQUERIES) ? nupdates : N_REQUERIES;
+
+    printf("array size: %ld, %d updates\n", (long)array_size, nupdates);
+
+    array_init = malloc(array_size * sizeof(pixelvalue));
+    array      = malloc(array_size * sizeof(pixelvalue));
+    idx        = malloc(nupdates * sizeof(int));
+    val        = malloc(nupdates * sizeof(pixelvalue));
+    if (array_init==NULL || array==NULL || idx==NULL || val==NULL) {
+        printf("memory allocation failure: aborting\n");
+        return ;
+    }
+    for (i=0 ; i<array_size; i++) {
+        array_init[i] = (pixelvalue)(lrand48() % MAX_ARRAY_VALUE);
+    }
+    for (i=0 ; i<nupdates ; i++) {
+        idx[i] = lrand48() % array_size;
+        val[i] = (pixelvalue)(lrand48() % MAX_ARRAY_VALUE);
+    }
+
+    //! benchmark the bulk load
+    chrono = clock();
+    os = ost_load(array_init, array_size);
+    elapsed = (double)(clock() - chrono) / (double)CLOCKS_PER_SEC;
+    if (os==NULL) {
+        printf("memory allocation failure: aborting\n");
+        return ;
+    }
+    printf("ostat bulk load :\t%5.3f sec\n", elapsed);
+    fflush(stdout);
+
+    //! array tracks the container; array_init is kept for the replay
+    memcpy(array, array_init, array_size * sizeof(pixelvalue));
+    chrono = clock();
+    for (i=0 ; i<nupdates ; i++) {
+        if (ost_update(os, array[idx[i]], val[i]) != 0) {
+            printf("ostat update failure: aborting\n");
+            ost_destroy(os);
+            return ;
+        }
+        array[idx[i]] = val[i];
+        ost_median(os, &last);
+        if (i < nq) med[i] = last;
+    }
+    t_tree = (double)(clock() - chrono) / (double)CLOCKS_PER_SEC;
+    printf("ostat update+med:\t%9.3f usec/query\tmed %g\n",
+           1e6 * t_tree / nupdates, (double)last);
+    fflush(stdout);
+
+    //! replay the first nq updates with a full quickselect per query
+    chrono = clock();
+    for (i=0 ; i<nq ; i++) {
+        array_init[idx[i]] = val[i];
+        memcpy(array, array_init, array_size * sizeof(pixelvalue));
+        qs[i] = quick_select(array, array_size);
+    }
+    t_qs = (double)(clock() - chrono) / (double)CLOCKS_PER_SEC;
+    printf("copy + QS       :\t%9.3f usec/query\n", 1e6 * t_qs / nq);
+    for (i=0 ; i<nq ; i++) {
+        if (fabs(med[i] - qs[i]) > 10 * FLT_EPSILON) {
+            printf("diverging median values!\n");
+            break;
+        }
+    }
+    printf("\n");
+    fflush(stdout);
+
+    ost_destroy(os);
+    free(val);
+    free(idx);
+    free(array);
+    free(array_init);
+    return;
+}
+
 //! This function is only useful to the qsort() routine
 int compare(const void *f1, const void *f2)
 { return ( *(pixelvalue*)f1 > *(pixelvalue*)f2) ? 1 : -1 ; }
@@ -384,10 +599,38 @@ int main(int argc, char * argv[])
         printf("%s <from> <to> <step>\n", argv[0]);
         printf("\twill loop over the number of elements in input\n");
         printf("\n");
+        printf("%s -r <runs> [n]\n", argv[0]);
+        printf("\tmedian of <runs> pre-sorted runs: copy + quick select\n");
+        printf("\tvs. median_runs, verbose for n=1 or n repeated attempts\n");
+        printf("\n");
+        printf("%s -u <updates> [size]\n", argv[0]);
+        printf("\tpoint update + median latency of the ostat container\n");
+        printf("\tvs. copy + quick select on every query\n");
+        printf("\n");
         exit(EXIT_FAILURE);
     }
 
-    if (argc==2) {
+    if (strcmp(argv[1], "-u")==0) {
+        if (argc<3) {
+            printf("missing number of updates\n");
+            exit(EXIT_FAILURE);
+        }
+        bench_updates((argc>3) ? (size_t)atol(argv[3]) : BIG_NUM, atoi(argv[2]));
+    } else if (strcmp(argv[1], "-r")==0) {
+        if (argc<3) {
+            printf("missing number of runs\n");
+            exit(EXIT_FAILURE);
+        }
+        count = (argc>3) ? atoi(argv[3]) : 1;
+        if (count<=1) {
+            bench_runs(1, BIG_NUM, atoi(argv[2]));
+        } else {
+            printf("Size\tRuns\tcopy+QS\tmedian_runs\n");
+            for (i=0 ; i<count ; i++) {
+                bench_runs(0, BIG_NUM, atoi(argv[2]));
+            }
+        }
+    } else if (argc==2) {
         count = atoi(argv[1]);
         if (count==1) {
             bench(1, BIG_NUM);
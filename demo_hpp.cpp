@@ -0,0 +1,198 @@
+/*! \file demo_hpp.cpp
+   \brief Benchmark of the C++ templates against the C entry points.
+
+   Each C routine from medians_1D.c is timed against its template
+   counterpart from medians_1D.hpp on the same data, followed by a
+   sliding-window test comparing quick_select() on 9-element windows
+   with the unrolled median_fixed<9>() network.  When built as C++20,
+   the std::span overloads get their own rows (quick_select() on a
+   dynamic span, median_fixed() on a static-extent span).  The output
+   format follows demo.c.
+
+   Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+   This code is licensed under the LGPLv3.  See the LICENSE file for
+   details.
+*/
+
+#include "medians_1D.h"
+#include "medians_1D.hpp"
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+
+//! Number of elements in the target array
+#define BIG_NUM (1024*1024)
+
+//! Random test data; generated values are in [0...MAX_ARRAY_VALUE-1]
+#define MAX_ARRAY_VALUE     1024
+
+//! Window size for the fixed-network test
+#define WINDOW      9
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+//! Time one median method on a fresh copy of the input
+template <class Method>
+pixelvalue run(int verbose, const char *name, const std::vector<pixelvalue> &init,
+               std::vector<pixelvalue> &array, Method method)
+{
+    pixelvalue  med;
+    double      elapsed;
+
+    std::memcpy(array.data(), init.data(), init.size() * sizeof(pixelvalue));
+    if (verbose) {
+        std::printf("%-16s:\t", name);
+        std::fflush(stdout);
+    }
+    bench_clock::time_point chrono = bench_clock::now();
+    med = method(array);
+    elapsed = std::chrono::duration<double>(bench_clock::now() - chrono).count();
+    if (verbose) {
+        std::printf("%5.3f sec\tmed %g\n", elapsed, (double)med);
+    } else {
+        std::printf("%5.3f\t", elapsed);
+    }
+    std::fflush(stdout);
+    return med;
+}
+
+void bench(int verbose, size_t array_size)
+{
+    std::vector<pixelvalue> med, win;
+
+    srand48(getpid());
+    if (array_size<1) array_size = BIG_NUM;
+
+    if (verbose) {
+        std::printf("array size: %ld\n", (long)array_size);
+    } else {
+        std::printf("%ld\t", (long)array_size);
+    }
+
+    std::vector<pixelvalue> array_init(array_size), array(array_size);
+    for (size_t i=0 ; i<array_size ; i++) {
+        array_init[i] = (pixelvalue)(lrand48() % MAX_ARRAY_VALUE);
+    }
+
+    med.push_back(run(verbose, "C quick select", array_init, array,
+        [](std::vector<pixelvalue> &a) {
+            return quick_select(a.data(), (int)a.size()); }));
+    med.push_back(run(verbose, "T quick select", array_init, array,
+        [](std::vector<pixelvalue> &a) {
+            return medians_1D::quick_select(a.begin(), a.end()); }));
+#ifdef MEDIANS_1D_HAVE_SPAN
+    med.push_back(run(verbose, "T span QS", array_init, array,
+        [](std::vector<pixelvalue> &a) {
+            return medians_1D::quick_select(std::span<pixelvalue>(a)); }));
+#endif
+    med.push_back(run(verbose, "C Wirth median", array_init, array,
+        [](std::vector<pixelvalue> &a) {
+            return wirth(a.data(), (int)a.size()); }));
+    med.push_back(run(verbose, "T Wirth median", array_init, array,
+        [](std::vector<pixelvalue> &a) {
+            return medians_1D::wirth(a.begin(), a.end()); }));
+    med.push_back(run(verbose, "C torben", array_init, array,
+        [](std::vector<pixelvalue> &a) {
+            return torben(a.data(), (int)a.size()); }));
+    med.push_back(run(verbose, "T torben", array_init, array,
+        [](std::vector<pixelvalue> &a) {
+            return medians_1D::torben(a.cbegin(), a.cend()); }));
+
+    //! sliding windows: the sum of all window medians is compared
+    size_t nwin = (array_size < WINDOW) ? 0 : array_size - WINDOW + 1;
+    win.push_back(run(verbose, "C QS window 9", array_init, array,
+        [nwin](std::vector<pixelvalue> &a) {
+            pixelvalue w[WINDOW], sum = 0;
+            for (size_t i=0 ; i<nwin ; i++) {
+                std::memcpy(w, &a[i], sizeof(w));
+                sum += quick_select(w, WINDOW);
+            }
+            return sum; }));
+    win.push_back(run(verbose, "T fixed window 9", array_init, array,
+        [nwin](std::vector<pixelvalue> &a) {
+            pixelvalue w[WINDOW], sum = 0;
+            for (size_t i=0 ; i<nwin ; i++) {
+                std::memcpy(w, &a[i], sizeof(w));
+                sum += medians_1D::median_fixed<WINDOW>(w);
+            }
+            return sum; }));
+#ifdef MEDIANS_1D_HAVE_SPAN
+    win.push_back(run(verbose, "T span window 9", array_init, array,
+        [nwin](std::vector<pixelvalue> &a) {
+            pixelvalue w[WINDOW], sum = 0;
+            for (size_t i=0 ; i<nwin ; i++) {
+                std::memcpy(w, &a[i], sizeof(w));
+                sum += medians_1D::median_fixed(std::span<pixelvalue, WINDOW>(w));
+            }
+            return sum; }));
+#endif
+
+    for (size_t i=1 ; i<med.size() ; i++) {
+        if (std::fabs(med[0] - med[i]) > 10 * FLT_EPSILON) {
+            std::printf("diverging median values!\n");
+        }
+    }
+    for (size_t i=1 ; i<win.size() ; i++) {
+        if (std::fabs(win[0] - win[i]) > 10 * FLT_EPSILON) {
+            std::printf("diverging window medians!\n");
+        }
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+} // namespace
+
+//! Main driver for the template benchmark
+int main(int argc, char * argv[])
+{
+    int     count;
+
+    if (argc<2) {
+        std::printf("usage:\n");
+        std::printf("%s <n>\n", argv[0]);
+        std::printf("\tif n=1 the output is verbose for one attempt\n");
+        std::printf("\tif n>1 the output reads:\n");
+        std::printf("\t# of elements | method1 | method2 | ...\n");
+        std::printf("\n");
+        std::printf("%s <from> <to> <step>\n", argv[0]);
+        std::printf("\twill loop over the number of elements in input\n");
+        std::printf("\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (argc==2) {
+        count = std::atoi(argv[1]);
+        if (count==1) {
+            bench(1, BIG_NUM);
+        } else {
+#ifdef MEDIANS_1D_HAVE_SPAN
+            std::printf("Size\tC QS\tT QS\tspan QS\tC Wirth\tT Wirth\t"
+                        "C Torben\tT Torben\tC win9\tT win9\tspan win9\n");
+#else
+            std::printf("Size\tC QS\tT QS\tC Wirth\tT Wirth\tC Torben\t"
+                        "T Torben\tC win9\tT win9\n");
+#endif
+            for (int i=0 ; i<count ; i++) {
+                bench(0, BIG_NUM);
+            }
+        }
+    } else if (argc==4) {
+        int from = std::atoi(argv[1]);
+        int to   = std::atoi(argv[2]);
+        int step = std::atoi(argv[3]);
+        for (count=from ; count<=to ; count+=step) {
+            bench(0, count);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,338 @@
+/***********************************************************************
+ * $RCSfile$
+ *
+ * Order-statistics container: a treap with one node per distinct
+ * value.  Nodes live in a single growable array and refer to each
+ * other by index (0 is the empty sentinel), so growing the array never
+ * invalidates links.  Each node keeps the count of its value and the
+ * number of elements in its subtree for rank queries.
+ *
+ * Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+ * $Date$
+ *
+ **********************************************************************/
+
+#include "median_ostat.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//! Initial node capacity of an empty container
+#define OST_MIN_NODES   16
+
+//! One distinct value; size counts all copies in the subtree
+typedef struct ost_node {
+    pixelvalue  key;
+    int         cnt;
+    int         size;
+    unsigned    prio;
+    int         left;
+    int         right;
+} ost_node;
+
+struct ostat {
+    ost_node *  node;       /* node[0] is the empty sentinel */
+    int         cap;
+    int         used;
+    int         free;       /* free list, linked through left */
+    int         root;
+    unsigned    seed;
+};
+
+//! xorshift32; treap priorities only need to be well mixed
+static unsigned ost_rand(ostat *os) {
+    unsigned x = os->seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return os->seed = x;
+}
+
+static void ost_pull(ost_node *nd, int t) {
+    nd[t].size = nd[t].cnt + nd[nd[t].left].size + nd[nd[t].right].size;
+}
+
+static int ost_rot_right(ost_node *nd, int t) {
+    int l = nd[t].left;
+
+    nd[t].left = nd[l].right;
+    nd[l].right = t;
+    ost_pull(nd, t);
+    ost_pull(nd, l);
+    return l;
+}
+
+static int ost_rot_left(ost_node *nd, int t) {
+    int r = nd[t].right;
+
+    nd[t].right = nd[r].left;
+    nd[r].left = t;
+    ost_pull(nd, t);
+    ost_pull(nd, r);
+    return r;
+}
+
+//! Join two treaps whose keys are all ordered a < b
+static int ost_merge(ost_node *nd, int a, int b) {
+    if (a==0) return b;
+    if (b==0) return a;
+    if (nd[a].prio > nd[b].prio) {
+        nd[a].right = ost_merge(nd, nd[a].right, b);
+        ost_pull(nd, a);
+        return a;
+    }
+    nd[b].left = ost_merge(nd, a, nd[b].left);
+    ost_pull(nd, b);
+    return b;
+}
+
+//! Insert node x below t, rotating it up while its priority is higher
+static int ost_link(ost_node *nd, int t, int x) {
+    if (t==0) return x;
+    if (nd[x].key < nd[t].key) {
+        nd[t].left = ost_link(nd, nd[t].left, x);
+        if (nd[nd[t].left].prio > nd[t].prio) return ost_rot_right(nd, t);
+    } else {
+        nd[t].right = ost_link(nd, nd[t].right, x);
+        if (nd[nd[t].right].prio > nd[t].prio) return ost_rot_left(nd, t);
+    }
+    ost_pull(nd, t);
+    return t;
+}
+
+//! Node holding v, or 0
+static int ost_find(const ostat *os, pixelvalue v) {
+    int t = os->root;
+
+    while (t != 0 && os->node[t].key != v)
+        t = (v < os->node[t].key) ? os->node[t].left : os->node[t].right;
+    return t;
+}
+
+//! Add cnt to every subtree size on the path to the node holding v
+static void ost_path_add(ostat *os, pixelvalue v, int cnt) {
+    int t = os->root;
+
+    while (t != 0) {
+        os->node[t].size += cnt;
+        if (os->node[t].key == v) break;
+        t = (v < os->node[t].key) ? os->node[t].left : os->node[t].right;
+    }
+}
+
+//! Take a node from the free list or the end of the array
+static int ost_alloc(ostat *os) {
+    ost_node *  nd;
+    int         t, cap;
+
+    if (os->free != 0) {
+        t = os->free;
+        os->free = os->node[t].left;
+        return t;
+    }
+    if (os->used == os->cap) {
+        cap = 2 * os->cap;
+        nd = realloc(os->node, cap * sizeof(ost_node));
+        if (nd==NULL) return 0;
+        os->node = nd;
+        os->cap = cap;
+    }
+    return os->used++;
+}
+
+static ostat *ost_alloc_tree(int cap) {
+    ostat * os;
+
+    if (cap < OST_MIN_NODES) cap = OST_MIN_NODES;
+    os = calloc(1, sizeof(*os));
+    if (os==NULL) return NULL;
+    os->node = malloc(cap * sizeof(ost_node));
+    if (os->node==NULL) {
+        free(os);
+        return NULL;
+    }
+    memset(&os->node[0], 0, sizeof(ost_node));
+    os->cap  = cap;
+    os->used = 1;
+    os->seed = 2463534242u;
+    return os;
+}
+
+ostat *ost_create(void) {
+    return ost_alloc_tree(OST_MIN_NODES);
+}
+
+//! This function is only useful to the qsort() routine
+static int compare_pixel(const void *f1, const void *f2) {
+    pixelvalue a = *(const pixelvalue *)f1;
+    pixelvalue b = *(const pixelvalue *)f2;
+    return (a > b) - (a < b);
+}
+
+//! Subtree sizes after a bottom-up build
+static int ost_fix_size(ost_node *nd, int t) {
+    if (t==0) return 0;
+    nd[t].size = nd[t].cnt + ost_fix_size(nd, nd[t].left)
+                           + ost_fix_size(nd, nd[t].right);
+    return nd[t].size;
+}
+
+ostat *ost_load(const pixelvalue a[], int n) {
+    ostat *     os;
+    ost_node *  nd;
+    pixelvalue *s;
+    int *       stack;
+    int         i, t, last, top = 0, sorted = 1;
+
+    for (i=1 ; i<n && sorted ; i++)
+        if (a[i] < a[i-1]) sorted = 0;
+
+    s = (pixelvalue *)a;
+    if (!sorted) {
+        s = malloc(n * sizeof(pixelvalue));
+        if (s==NULL) return NULL;
+        memcpy(s, a, n * sizeof(pixelvalue));
+        qsort(s, n, sizeof(pixelvalue), compare_pixel);
+    }
+
+    os = ost_alloc_tree(n + 1);
+    stack = malloc((n + 1) * sizeof(int));
+    if (os==NULL || stack==NULL) {
+        ost_destroy(os);
+        free(stack);
+        if (s != a) free(s);
+        return NULL;
+    }
+    nd = os->node;
+
+    /* one node per run of equal values, linked as a Cartesian tree */
+    for (i=0 ; i<n ; i++) {
+        if (i>0 && s[i] == s[i-1]) {
+            nd[os->used - 1].cnt++;
+            continue;
+        }
+        t = os->used++;
+        nd[t].key   = s[i];
+        nd[t].cnt   = 1;
+        nd[t].prio  = ost_rand(os);
+        nd[t].left  = 0;
+        nd[t].right = 0;
+
+        last = 0;
+        while (top > 0 && nd[stack[top-1]].prio < nd[t].prio)
+            last = stack[--top];
+        nd[t].left = last;
+        if (top > 0) nd[stack[top-1]].right = t;
+        stack[top++] = t;
+    }
+    os->root = (top > 0) ? stack[0] : 0;
+    ost_fix_size(nd, os->root);
+
+    free(stack);
+    if (s != a) free(s);
+    return os;
+}
+
+void ost_destroy(ostat *os) {
+    if (os==NULL) return;
+    free(os->node);
+    free(os);
+}
+
+int ost_insert(ostat *os, pixelvalue v) {
+    int     t;
+
+    t = ost_find(os, v);
+    if (t != 0) {
+        os->node[t].cnt++;
+        ost_path_add(os, v, 1);
+        return 0;
+    }
+    t = ost_alloc(os);
+    if (t==0) return -1;
+    os->node[t].key   = v;
+    os->node[t].cnt   = 1;
+    os->node[t].size  = 1;
+    os->node[t].prio  = ost_rand(os);
+    os->node[t].left  = 0;
+    os->node[t].right = 0;
+    os->root = ost_link(os->node, os->root, t);
+    return 0;
+}
+
+int ost_delete(ostat *os, pixelvalue v) {
+    ost_node *  nd = os->node;
+    int *       link;
+    int         t;
+
+    t = ost_find(os, v);
+    if (t==0) return -1;
+    if (nd[t].cnt > 1) {
+        nd[t].cnt--;
+        ost_path_add(os, v, -1);
+        return 0;
+    }
+
+    /* last copy: shrink the path, then splice the node out */
+    link = &os->root;
+    while (nd[*link].key != v) {
+        nd[*link].size--;
+        link = (v < nd[*link].key) ? &nd[*link].left : &nd[*link].right;
+    }
+    *link = ost_merge(nd, nd[t].left, nd[t].right);
+    nd[t].left = os->free;
+    os->free = t;
+    return 0;
+}
+
+int ost_update(ostat *os, pixelvalue old, pixelvalue v) {
+    if (old == v) return (ost_find(os, old) != 0) ? 0 : -1;
+    if (ost_delete(os, old) != 0) return -1;
+    if (ost_insert(os, v) != 0) {
+        /* cannot fail: deleting old freed a node or left its count > 0 */
+        ost_insert(os, old);
+        return -1;
+    }
+    return 0;
+}
+
+int ost_size(const ostat *os) {
+    return os->node[os->root].size;
+}
+
+//! Function implementing the rank walk from the root
+/*!
+   Function :   ost_kth()
+    - In    :   container, rank k, result
+    - Out   :   0 on success, -1 on bad rank
+*/
+
+int
+#ifdef __GNUC__
+__attribute__((__no_instrument_function__))
+#endif
+ost_kth(const ostat *os, int k, pixelvalue *kth) {
+    const ost_node *nd = os->node;
+    int             t = os->root, ls;
+
+    if (k<0 || k>=nd[t].size) return -1;
+    while (t != 0) {
+        ls = nd[nd[t].left].size;
+        if (k < ls) {
+            t = nd[t].left;
+        } else if (k < ls + nd[t].cnt) {
+            *kth = nd[t].key;
+            return 0;
+        } else {
+            k -= ls + nd[t].cnt;
+            t = nd[t].right;
+        }
+    }
+    return -1;
+}
+
+int ost_median(const ostat *os, pixelvalue *med) {
+    if (ost_size(os)==0) return -1;
+    return ost_kth(os, (ost_size(os) - 1) / 2, med);
+}
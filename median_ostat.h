@@ -0,0 +1,101 @@
+/*! \file median_ostat.h
+   \brief Order-statistics container for medians of mutable data.
+
+   The container is a treap (a binary search tree kept balanced by
+   random heap priorities) with one node per distinct value.  Each
+   node stores how many copies of its value are held and the number
+   of elements in its subtree, so repeated values cost nothing extra
+   and a rank query is a single root-to-leaf walk.  Insert, delete,
+   update and k-th queries take expected O(log d) time for d distinct
+   values, independent of how the values are distributed.
+
+   Bulk loading sorts a copy of the input and builds the tree bottom
+   up in linear time, so it is O(n log n) in general and O(n) when the
+   input is already in ascending order.
+
+   Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+   This code is licensed under the LGPLv3.  See the LICENSE file for
+   details.
+ */
+
+#ifndef _MEDIAN_OSTAT_H_
+#define _MEDIAN_OSTAT_H_
+
+#include "medians_1D.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! \var typedef ostat
+    \brief Opaque order-statistics container
+*/
+typedef struct ostat ostat;
+
+/////////////////////////////////////////////////////////////////////////
+
+/*! \fn ostat *ost_create(void)
+   \brief Empty container, or NULL on allocation failure
+ */
+ostat *ost_create(void);
+
+/*! \fn ostat *ost_load(const pixelvalue a[], int n)
+   \brief Bulk-load a container from an array
+
+   Function  :   ost_load()
+    - In     :   array of elements, # of elements
+    - Out    :   container, or NULL on allocation failure
+    - Job    :   copy the elements; a is not modified
+ */
+ostat *ost_load(const pixelvalue a[], int n);
+
+/*! \fn void ost_destroy(ostat *os)
+   \brief Release a container
+ */
+void ost_destroy(ostat *os);
+
+/*! \fn int ost_insert(ostat *os, pixelvalue v)
+   \brief Add one element (0 on success, -1 on allocation failure)
+ */
+int ost_insert(ostat *os, pixelvalue v);
+
+/*! \fn int ost_delete(ostat *os, pixelvalue v)
+   \brief Remove one element equal to v (0 on success, -1 if absent)
+ */
+int ost_delete(ostat *os, pixelvalue v);
+
+/*! \fn int ost_update(ostat *os, pixelvalue old, pixelvalue v)
+   \brief Replace one element equal to old by v
+
+   Returns -1, leaving the container unchanged, if old is absent or
+   memory for v cannot be allocated.
+ */
+int ost_update(ostat *os, pixelvalue old, pixelvalue v);
+
+/*! \fn int ost_size(const ostat *os)
+   \brief Number of elements currently held
+ */
+int ost_size(const ostat *os);
+
+/*! \fn int ost_kth(const ostat *os, int k, pixelvalue *kth)
+   \brief Rank query
+
+   Function  :   ost_kth()
+    - In     :   container, rank k (0-based), result
+    - Out    :   0 on success, -1 if k is outside [0, ost_size())
+    - Job    :   find the kth smallest element held
+ */
+int ost_kth(const ostat *os, int k, pixelvalue *kth);
+
+/*! \fn int ost_median(const ostat *os, pixelvalue *med)
+   \brief Lower median of the elements held, as quick_select() returns
+
+   Returns -1 if the container is empty.
+ */
+int ost_median(const ostat *os, pixelvalue *med);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+/***********************************************************************
+ * $RCSfile$
+ *
+ * Partition-aware exact median.  Torben's inner loop is split into a
+ * shard-side count (part_count) and a coordinator-side range update
+ * (part_coord_update); the shard replies merge by addition and
+ * min/max, so the coordinator never needs the data itself.
+ *
+ * Algorithm by Torben Mogensen, original code by N. Devillard.
+ * Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+ * $Date$
+ *
+ **********************************************************************/
+
+#include "median_partition.h"
+
+#include <stddef.h>
+
+void part_summarize(const pixelvalue m[], int n, part_summary *s) {
+    int     i;
+
+    s->n = n;
+    s->min = s->max = 0;
+    if (n<1) return;
+    s->min = s->max = m[0];
+    for (i=1 ; i<n ; i++) {
+        if (m[i]<s->min) s->min=m[i];
+        if (m[i]>s->max) s->max=m[i];
+    }
+}
+
+void part_merge_summary(part_summary *acc, const part_summary *s) {
+    if (s->n<1) return;
+    if (acc->n<1) {
+        *acc = *s;
+        return;
+    }
+    acc->n += s->n;
+    if (s->min<acc->min) acc->min=s->min;
+    if (s->max>acc->max) acc->max=s->max;
+}
+
+void part_counts_init(part_counts *c) {
+    c->less = 0; c->equal = 0; c->greater = 0;
+    c->maxlt = 0; c->mingt = 0;
+    c->has_lt = 0; c->has_gt = 0;
+}
+
+//! Function implementing the shard side of one Torben round
+/*!
+   Function :   part_count()
+    - In    :   shard elements, # of elements, guess, reply
+    - Out   :   void
+*/
+void
+#ifdef __GNUC__
+__attribute__((__no_instrument_function__))
+#endif
+part_count(const pixelvalue m[], int n, pixelvalue guess, part_counts *c) {
+    int         i;
+    long        less = 0, greater = 0, equal = 0;
+    pixelvalue  maxlt = guess, mingt = guess;
+
+    for (i=0; i<n; i++) {
+        if (m[i]<guess) {
+            if (!less++ || m[i]>maxlt) maxlt = m[i];
+        } else if (m[i]>guess) {
+            if (!greater++ || m[i]<mingt) mingt = m[i];
+        } else equal++;
+    }
+    c->less = less; c->equal = equal; c->greater = greater;
+    c->maxlt = maxlt; c->mingt = mingt;
+    c->has_lt = (less > 0);
+    c->has_gt = (greater > 0);
+}
+
+void part_merge_counts(part_counts *acc, const part_counts *c) {
+    acc->less    += c->less;
+    acc->equal   += c->equal;
+    acc->greater += c->greater;
+    if (c->has_lt && (!acc->has_lt || c->maxlt>acc->maxlt)) {
+        acc->maxlt = c->maxlt;
+        acc->has_lt = 1;
+    }
+    if (c->has_gt && (!acc->has_gt || c->mingt<acc->mingt)) {
+        acc->mingt = c->mingt;
+        acc->has_gt = 1;
+    }
+}
+
+void part_coord_init(part_coord *pc, const part_summary *all) {
+    pc->half   = (all->n+1)/2;
+    pc->min    = all->min;
+    pc->max    = all->max;
+    pc->guess  = (pc->min+pc->max)/2;
+    pc->median = pc->guess;
+    pc->rounds = 0;
+    pc->done   = (all->n<1);
+}
+
+pixelvalue part_coord_guess(const part_coord *pc) {
+    return pc->guess;
+}
+
+int part_coord_update(part_coord *pc, const part_counts *all) {
+    pixelvalue  maxltguess, mingtguess;
+
+    if (pc->done) return 1;
+    pc->rounds++;
+
+    /* Torben starts both neighbours at the current range limits */
+    maxltguess = (all->has_lt && all->maxlt>pc->min) ? all->maxlt : pc->min;
+    mingtguess = (all->has_gt && all->mingt<pc->max) ? all->mingt : pc->max;
+
+    if (all->less <= pc->half && all->greater <= pc->half) {
+        if (all->less >= pc->half) pc->median = maxltguess;
+        else if (all->less+all->equal >= pc->half) pc->median = pc->guess;
+        else pc->median = mingtguess;
+        pc->done = 1;
+        return 1;
+    }
+    if (all->less>all->greater) pc->max = maxltguess;
+    else pc->min = mingtguess;
+    pc->guess = (pc->min+pc->max)/2;
+    return 0;
+}
+
+//! Function driving the protocol over local shards
+/*!
+   Function :   torben_partitioned()
+    - In    :   shard pointers, shard lengths, # of shards, result
+    - Out   :   0 on success, -1 if there are no elements
+*/
+int torben_partitioned(pixelvalue *parts[], int lens[], int nparts,
+                       pixelvalue *med) {
+    part_summary    s, all;
+    part_counts     c, acc;
+    part_coord      pc;
+    pixelvalue      guess;
+    int             i;
+
+    part_summarize(NULL, 0, &all);
+    for (i=0 ; i<nparts ; i++) {
+        part_summarize(parts[i], lens[i], &s);
+        part_merge_summary(&all, &s);
+    }
+    if (all.n<1) return -1;
+    part_coord_init(&pc, &all);
+
+    while (!pc.done) {
+        guess = part_coord_guess(&pc);
+        part_counts_init(&acc);
+        for (i=0 ; i<nparts ; i++) {
+            part_count(parts[i], lens[i], guess, &c);
+            part_merge_counts(&acc, &c);
+        }
+        part_coord_update(&pc, &acc);
+    }
+    *med = pc.median;
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*! \file median_partition.h
+   \brief Exact median over partitioned data using Torben's counts.
+
+   Torben's method only needs, for a guess, the number of elements
+   below, at and above it plus the nearest neighbours on each side.
+   Those answers merge by simple addition and min/max, so each shard
+   can answer a query on its own data and a coordinator can narrow
+   the search range from the merged reply.  Only small fixed-size
+   messages are exchanged: one summary per shard, then one counts
+   reply per shard per round.  The result is the same element the
+   torben() function returns on the concatenated data.
+
+   The message structs are plain data; callers shipping them between
+   machines are responsible for their own encoding.
+
+   Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+   This code is licensed under the LGPLv3.  See the LICENSE file for
+   details.
+ */
+
+#ifndef _MEDIAN_PARTITION_H_
+#define _MEDIAN_PARTITION_H_
+
+#include "medians_1D.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+
+/*! \struct part_summary
+    \brief First-round shard reply: element count and value range
+*/
+typedef struct part_summary {
+    long        n;
+    pixelvalue  min;
+    pixelvalue  max;
+} part_summary;
+
+/*! \struct part_counts
+    \brief Per-round shard reply to a pivot query
+
+    - less, equal, greater :   elements below, at and above the guess
+    - maxlt, has_lt        :   largest element below the guess, if any
+    - mingt, has_gt        :   smallest element above the guess, if any
+*/
+typedef struct part_counts {
+    long        less;
+    long        equal;
+    long        greater;
+    pixelvalue  maxlt;
+    pixelvalue  mingt;
+    int         has_lt;
+    int         has_gt;
+} part_counts;
+
+/*! \struct part_coord
+    \brief Coordinator state for the partitioned Torben search
+*/
+typedef struct part_coord {
+    long        half;
+    pixelvalue  min;
+    pixelvalue  max;
+    pixelvalue  guess;
+    pixelvalue  median;
+    int         rounds;
+    int         done;
+} part_coord;
+
+/////////////////////////////////////////////////////////////////////////
+
+/*! \fn void part_summarize(const pixelvalue m[], int n, part_summary *s)
+   \brief Shard side of the first round: count and min/max of a shard
+ */
+void part_summarize(const pixelvalue m[], int n, part_summary *s);
+
+/*! \fn void part_merge_summary(part_summary *acc, const part_summary *s)
+   \brief Fold one shard summary into acc
+
+   Start acc from part_summarize(NULL, 0, acc), the empty summary.
+ */
+void part_merge_summary(part_summary *acc, const part_summary *s);
+
+/*! \fn void part_count(const pixelvalue m[], int n, pixelvalue guess, part_counts *c)
+   \brief Shard side of a round: Torben's counts for one guess
+
+   Function  :   part_count()
+    - In     :   shard elements, # of elements, pivot guess, reply
+    - Out    :   void
+    - Job    :   count elements below, at and above the guess and find
+                 the nearest neighbours on either side
+ */
+void part_count(const pixelvalue m[], int n, pixelvalue guess,
+                part_counts *c);
+
+/*! \fn void part_counts_init(part_counts *c)
+   \brief Empty counts, the identity for part_merge_counts()
+ */
+void part_counts_init(part_counts *c);
+
+/*! \fn void part_merge_counts(part_counts *acc, const part_counts *c)
+   \brief Fold one shard reply into acc
+ */
+void part_merge_counts(part_counts *acc, const part_counts *c);
+
+/*! \fn void part_coord_init(part_coord *pc, const part_summary *all)
+   \brief Start a search from the merged first-round summary
+ */
+void part_coord_init(part_coord *pc, const part_summary *all);
+
+/*! \fn pixelvalue part_coord_guess(const part_coord *pc)
+   \brief Pivot to send to every shard in the next round
+ */
+pixelvalue part_coord_guess(const part_coord *pc);
+
+/*! \fn int part_coord_update(part_coord *pc, const part_counts *all)
+   \brief Narrow the range from the merged replies to the current guess
+
+   Function  :   part_coord_update()
+    - In     :   coordinator state, merged counts for part_coord_guess()
+    - Out    :   1 when the median is known (in pc->median), 0 otherwise
+ */
+int part_coord_update(part_coord *pc, const part_counts *all);
+
+/*! \fn int torben_partitioned(pixelvalue *parts[], int lens[], int nparts, pixelvalue *med)
+   \brief In-process reference driver for the protocol
+
+   Runs the summary round and the count rounds over nparts local
+   shards; equivalent to torben() on the concatenated shards.  Returns
+   -1 if all the shards are empty.
+ */
+int torben_partitioned(pixelvalue *parts[], int lens[], int nparts,
+                       pixelvalue *med);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,384 @@
+/***********************************************************************
+ * $RCSfile$
+ *
+ * Concurrent per-channel median service.  Producers push samples into
+ * bounded multi-producer rings (one per channel); a single drain
+ * thread moves them into a "fill" window and, every period, swaps it
+ * with the "ready" window handed to the worker pool.  Workers run
+ * quick_select() on the ready window and publish the result through a
+ * seqlock.  Nothing on the ingestion path takes a lock or waits.
+ *
+ * Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+ * $Date$
+ *
+ **********************************************************************/
+
+#include "median_service.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+//! Cache line size used to keep hot atomics apart
+#define MS_CACHE_LINE   64
+
+//! Back-off when a thread finds nothing to do (nanoseconds)
+#define MS_IDLE_NS      50000
+
+//! Window states shared between the drain thread and the workers
+enum { MS_IDLE = 0, MS_READY, MS_BUSY };
+
+//! One ring slot; seq implements the bounded MPMC queue protocol
+typedef struct ms_cell {
+    atomic_size_t   seq;
+    pixelvalue      value;
+    uint64_t        stamp;
+} ms_cell;
+
+//! Per-channel state: ring, double-buffered windows and result seqlock
+typedef struct ms_channel {
+    /* producer side */
+    _Alignas(MS_CACHE_LINE) atomic_size_t tail;
+    atomic_ulong    dropped;
+
+    /* drain thread side */
+    _Alignas(MS_CACHE_LINE) ms_cell *cells;
+    size_t          mask;
+    size_t          head;
+    pixelvalue *    fill;
+    int             fill_count;
+    uint64_t        fill_first;
+    unsigned long   windows;
+
+    /* handed over to a worker while state != MS_IDLE */
+    pixelvalue *    ready;
+    int             ready_count;
+    uint64_t        ready_first;
+    uint64_t        ready_close;
+    unsigned long   ready_window;
+    atomic_int      state;
+
+    /* published result */
+    _Alignas(MS_CACHE_LINE) atomic_uint seq;
+    _Atomic pixelvalue  r_median;
+    atomic_int      r_count;
+    atomic_ulong    r_window;
+    _Atomic uint64_t r_first;
+    _Atomic uint64_t r_close;
+    _Atomic uint64_t r_publish;
+} ms_channel;
+
+struct median_service {
+    ms_channel *    chan;
+    int             channels;
+    int             window_max;
+    int             workers;
+    uint64_t        period_ns;
+    atomic_int      running;
+    int             started;
+    pthread_t       drainer;
+    pthread_t *     pool;
+};
+
+//! Small argument block for each pool thread
+typedef struct ms_worker_arg {
+    median_service *svc;
+    int             id;
+} ms_worker_arg;
+
+uint64_t ms_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void ms_pause(long ns) {
+    struct timespec ts;
+
+    ts.tv_sec = 0;
+    ts.tv_nsec = ns;
+    nanosleep(&ts, NULL);
+}
+
+median_service *ms_create(int channels, int ring_size, int window_max,
+                          int workers, long period_us) {
+    median_service *svc;
+    size_t          size, bytes;
+    int             c;
+    size_t          i;
+
+    if (channels<1 || ring_size<2 || window_max<1 || workers<1 || period_us<1)
+        return NULL;
+
+    for (size=2 ; size<(size_t)ring_size ; size<<=1) ;
+
+    svc = calloc(1, sizeof(*svc));
+    if (svc==NULL) return NULL;
+
+    bytes = channels * sizeof(ms_channel);
+    bytes = (bytes + MS_CACHE_LINE - 1) & ~(size_t)(MS_CACHE_LINE - 1);
+    svc->chan = aligned_alloc(MS_CACHE_LINE, bytes);
+    svc->pool = calloc(workers, sizeof(pthread_t));
+    if (svc->chan==NULL || svc->pool==NULL) {
+        free(svc->chan);
+        free(svc->pool);
+        free(svc);
+        return NULL;
+    }
+    memset(svc->chan, 0, bytes);
+
+    svc->channels   = channels;
+    svc->window_max = window_max;
+    svc->workers    = workers;
+    svc->period_ns  = (uint64_t)period_us * 1000u;
+
+    for (c=0 ; c<channels ; c++) {
+        ms_channel *ch = &svc->chan[c];
+
+        ch->cells = malloc(size * sizeof(ms_cell));
+        ch->fill  = malloc(window_max * sizeof(pixelvalue));
+        ch->ready = malloc(window_max * sizeof(pixelvalue));
+        ch->mask  = size - 1;
+        if (ch->cells==NULL || ch->fill==NULL || ch->ready==NULL) {
+            svc->channels = c + 1;
+            ms_destroy(svc);
+            return NULL;
+        }
+        for (i=0 ; i<size ; i++)
+            atomic_init(&ch->cells[i].seq, i);
+        atomic_init(&ch->tail, 0);
+        atomic_init(&ch->state, MS_IDLE);
+        atomic_init(&ch->seq, 0);
+        atomic_init(&ch->r_window, 0);
+    }
+    return svc;
+}
+
+int ms_push(median_service *svc, int channel, pixelvalue v) {
+    ms_channel *ch;
+    ms_cell *   cell;
+    size_t      pos, seq;
+    intptr_t    diff;
+
+    if (channel<0 || channel>=svc->channels) return -1;
+    ch = &svc->chan[channel];
+
+    pos = atomic_load_explicit(&ch->tail, memory_order_relaxed);
+    for (;;) {
+        cell = &ch->cells[pos & ch->mask];
+        seq  = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff==0) {
+            if (atomic_compare_exchange_weak_explicit(&ch->tail, &pos, pos+1,
+                    memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff<0) {
+            atomic_fetch_add_explicit(&ch->dropped, 1, memory_order_relaxed);
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&ch->tail, memory_order_relaxed);
+        }
+    }
+    cell->value = v;
+    cell->stamp = ms_now_ns();
+    atomic_store_explicit(&cell->seq, pos+1, memory_order_release);
+    return 0;
+}
+
+//! Move everything currently queued on a channel into its fill window
+static int ms_drain_channel(median_service *svc, ms_channel *ch) {
+    ms_cell *   cell;
+    int         moved = 0;
+
+    for (;;) {
+        cell = &ch->cells[ch->head & ch->mask];
+        if (atomic_load_explicit(&cell->seq, memory_order_acquire) != ch->head+1)
+            break;
+        if (ch->fill_count < svc->window_max) {
+            if (ch->fill_count==0) ch->fill_first = cell->stamp;
+            ch->fill[ch->fill_count++] = cell->value;
+        } else {
+            atomic_fetch_add_explicit(&ch->dropped, 1, memory_order_relaxed);
+        }
+        atomic_store_explicit(&cell->seq, ch->head + ch->mask + 1,
+                              memory_order_release);
+        ch->head++;
+        moved++;
+    }
+    return moved;
+}
+
+//! Swap fill and ready windows; an unfinished ready window extends this one
+static void ms_close_window(ms_channel *ch, uint64_t now) {
+    pixelvalue *tmp;
+
+    if (ch->fill_count==0) return;
+    if (atomic_load_explicit(&ch->state, memory_order_acquire) != MS_IDLE)
+        return;
+
+    tmp = ch->ready;
+    ch->ready        = ch->fill;
+    ch->ready_count  = ch->fill_count;
+    ch->ready_first  = ch->fill_first;
+    ch->ready_close  = now;
+    ch->ready_window = ++ch->windows;
+    ch->fill         = tmp;
+    ch->fill_count   = 0;
+    atomic_store_explicit(&ch->state, MS_READY, memory_order_release);
+}
+
+static void *ms_drain(void *arg) {
+    median_service *svc = arg;
+    uint64_t        now, next;
+    int             c, moved;
+
+    next = ms_now_ns() + svc->period_ns;
+    while (atomic_load_explicit(&svc->running, memory_order_relaxed)) {
+        moved = 0;
+        for (c=0 ; c<svc->channels ; c++)
+            moved += ms_drain_channel(svc, &svc->chan[c]);
+
+        now = ms_now_ns();
+        if (now >= next) {
+            for (c=0 ; c<svc->channels ; c++)
+                ms_close_window(&svc->chan[c], now);
+            next += svc->period_ns;
+            if (next <= now) next = now + svc->period_ns;
+        }
+        if (!moved) ms_pause(MS_IDLE_NS);
+    }
+    return NULL;
+}
+
+//! Seqlock writer; only the worker holding the channel in MS_BUSY calls it
+static void ms_publish(ms_channel *ch, pixelvalue median) {
+    unsigned    s;
+
+    s = atomic_load_explicit(&ch->seq, memory_order_relaxed);
+    atomic_store_explicit(&ch->seq, s+1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&ch->r_median, median, memory_order_relaxed);
+    atomic_store_explicit(&ch->r_count, ch->ready_count, memory_order_relaxed);
+    atomic_store_explicit(&ch->r_window, ch->ready_window, memory_order_relaxed);
+    atomic_store_explicit(&ch->r_first, ch->ready_first, memory_order_relaxed);
+    atomic_store_explicit(&ch->r_close, ch->ready_close, memory_order_relaxed);
+    atomic_store_explicit(&ch->r_publish, ms_now_ns(), memory_order_relaxed);
+
+    atomic_store_explicit(&ch->seq, s+2, memory_order_release);
+}
+
+static void *ms_work(void *arg) {
+    ms_worker_arg * wa = arg;
+    median_service *svc = wa->svc;
+    ms_channel *    ch;
+    int             i, c, found, expect;
+
+    while (atomic_load_explicit(&svc->running, memory_order_relaxed)) {
+        found = 0;
+        for (i=0 ; i<svc->channels ; i++) {
+            c  = (i + wa->id) % svc->channels;
+            ch = &svc->chan[c];
+            expect = MS_READY;
+            if (!atomic_compare_exchange_strong_explicit(&ch->state, &expect,
+                    MS_BUSY, memory_order_acquire, memory_order_relaxed))
+                continue;
+            ms_publish(ch, quick_select(ch->ready, ch->ready_count));
+            atomic_store_explicit(&ch->state, MS_IDLE, memory_order_release);
+            found++;
+        }
+        if (!found) ms_pause(MS_IDLE_NS);
+    }
+    free(wa);
+    return NULL;
+}
+
+int ms_start(median_service *svc) {
+    ms_worker_arg * wa;
+    int             w;
+
+    if (svc->started) return -1;
+    atomic_store(&svc->running, 1);
+
+    if (pthread_create(&svc->drainer, NULL, ms_drain, svc) != 0) {
+        atomic_store(&svc->running, 0);
+        return -1;
+    }
+    svc->started = 1;
+    for (w=0 ; w<svc->workers ; w++) {
+        wa = malloc(sizeof(*wa));
+        if (wa==NULL) break;
+        wa->svc = svc;
+        wa->id  = w;
+        if (pthread_create(&svc->pool[w], NULL, ms_work, wa) != 0) {
+            free(wa);
+            break;
+        }
+    }
+    if (w < svc->workers) {
+        svc->workers = w;
+        ms_stop(svc);
+        return -1;
+    }
+    return 0;
+}
+
+void ms_stop(median_service *svc) {
+    int     w;
+
+    if (!svc->started) return;
+    atomic_store(&svc->running, 0);
+    pthread_join(svc->drainer, NULL);
+    for (w=0 ; w<svc->workers ; w++)
+        pthread_join(svc->pool[w], NULL);
+    svc->started = 0;
+}
+
+void ms_destroy(median_service *svc) {
+    int     c;
+
+    if (svc==NULL) return;
+    ms_stop(svc);
+    for (c=0 ; c<svc->channels ; c++) {
+        free(svc->chan[c].cells);
+        free(svc->chan[c].fill);
+        free(svc->chan[c].ready);
+    }
+    free(svc->chan);
+    free(svc->pool);
+    free(svc);
+}
+
+int ms_read(median_service *svc, int channel, ms_result *res) {
+    ms_channel *ch;
+    unsigned    s0, s1;
+
+    if (channel<0 || channel>=svc->channels) return -1;
+    ch = &svc->chan[channel];
+
+    do {
+        s0 = atomic_load_explicit(&ch->seq, memory_order_acquire);
+        if (s0 & 1) continue;
+        res->median     = atomic_load_explicit(&ch->r_median, memory_order_relaxed);
+        res->count      = atomic_load_explicit(&ch->r_count, memory_order_relaxed);
+        res->window     = atomic_load_explicit(&ch->r_window, memory_order_relaxed);
+        res->first_ns   = atomic_load_explicit(&ch->r_first, memory_order_relaxed);
+        res->close_ns   = atomic_load_explicit(&ch->r_close, memory_order_relaxed);
+        res->publish_ns = atomic_load_explicit(&ch->r_publish, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        s1 = atomic_load_explicit(&ch->seq, memory_order_relaxed);
+    } while ((s0 & 1) || s0 != s1);
+
+    /* windows are numbered from 1; seq itself may wrap back to 0 */
+    return (res->window==0) ? -1 : 0;
+}
+
+unsigned long ms_dropped(median_service *svc, int channel) {
+    if (channel<0 || channel>=svc->channels) return 0;
+    return atomic_load_explicit(&svc->chan[channel].dropped,
+                                memory_order_relaxed);
+}
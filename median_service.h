@@ -0,0 +1,122 @@
+/*! \file median_service.h
+   \brief Concurrent per-channel median service built on quick_select().
+
+   Many producer threads push samples into per-channel lock-free ring
+   buffers; a drain thread moves them into double-buffered windows and
+   a small worker pool runs quick_select() on each closed window.  The
+   results are published through a per-channel seqlock, so readers never
+   block writers and producers never wait on a median computation.
+
+   Samples that arrive while a ring (or the filling window) is full are
+   dropped and counted rather than stalling the producer.
+
+   Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+   This code is licensed under the LGPLv3.  See the LICENSE file for
+   details.
+ */
+
+#ifndef _MEDIAN_SERVICE_H_
+#define _MEDIAN_SERVICE_H_
+
+#include "medians_1D.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+
+/*! \struct ms_result
+    \brief Snapshot of the last published window for one channel.
+
+    - median     :   median of the window (lower median for even counts)
+    - count      :   number of samples in the window
+    - window     :   window sequence number, starting from 1
+    - first_ns   :   ingestion time of the oldest sample in the window
+    - close_ns   :   time the window was closed and handed to a worker
+    - publish_ns :   time the median was published
+
+    All times are CLOCK_MONOTONIC nanoseconds as returned by ms_now_ns().
+*/
+typedef struct ms_result {
+    pixelvalue      median;
+    int             count;
+    unsigned long   window;
+    uint64_t        first_ns;
+    uint64_t        close_ns;
+    uint64_t        publish_ns;
+} ms_result;
+
+/*! \var typedef median_service
+    \brief Opaque service handle.
+*/
+typedef struct median_service median_service;
+
+/////////////////////////////////////////////////////////////////////////
+
+/*! \fn median_service *ms_create(int, int, int, int, long)
+   \brief Allocate a median service
+
+   Function  :   ms_create()
+    - In     :   # of channels, ring size per channel (rounded up to a
+                 power of two), max samples per window, # of worker
+                 threads, window period in microseconds
+    - Out    :   service handle, or NULL on bad arguments/allocation failure
+    - Job    :   allocate rings, windows and result slots; no threads yet
+ */
+median_service *ms_create(int channels, int ring_size, int window_max,
+                          int workers, long period_us);
+
+/*! \fn int ms_start(median_service *)
+   \brief Start the drain thread and the worker pool (0 on success)
+ */
+int ms_start(median_service *svc);
+
+/*! \fn void ms_stop(median_service *)
+   \brief Stop and join all service threads; pending windows are discarded
+ */
+void ms_stop(median_service *svc);
+
+/*! \fn void ms_destroy(median_service *)
+   \brief Stop the service if needed and release all memory
+ */
+void ms_destroy(median_service *svc);
+
+/*! \fn int ms_push(median_service *, int, pixelvalue)
+   \brief Lock-free multi-producer ingestion
+
+   Function  :   ms_push()
+    - In     :   service, channel, sample value
+    - Out    :   0 if queued, -1 if the ring was full (sample dropped)
+    - Job    :   stamp the sample and append it to the channel ring
+    - Note   :   never blocks; safe to call from any number of threads
+ */
+int ms_push(median_service *svc, int channel, pixelvalue v);
+
+/*! \fn int ms_read(median_service *, int, ms_result *)
+   \brief Read the latest published result for a channel
+
+   Function  :   ms_read()
+    - In     :   service, channel, result to fill in
+    - Out    :   0 if a result was available, -1 otherwise
+    - Note   :   seqlock reader; retries while a publish is in flight
+ */
+int ms_read(median_service *svc, int channel, ms_result *res);
+
+/*! \fn unsigned long ms_dropped(median_service *, int)
+   \brief Number of samples dropped on a channel so far
+ */
+unsigned long ms_dropped(median_service *svc, int channel);
+
+/*! \fn uint64_t ms_now_ns(void)
+   \brief CLOCK_MONOTONIC time in nanoseconds
+ */
+uint64_t ms_now_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -209,3 +209,130 @@ torben(pixelvalue m[], int n) {
     else return mingtguess;
 }
 
+
+//! Candidate pivot for kth_smallest_runs(): a run middle and its weight
+typedef struct run_mid {
+    pixelvalue  value;
+    int         weight;
+} run_mid;
+
+//! This function is only useful to the qsort() routine
+static int compare_run_mid(const void *f1, const void *f2) {
+    pixelvalue a = ((const run_mid *)f1)->value;
+    pixelvalue b = ((const run_mid *)f2)->value;
+    return (a > b) - (a < b);
+}
+
+//! First index in [lo,hi) whose element is not less than (or, when
+//! upper is set, greater than) v
+static int run_bound(const pixelvalue r[], int lo, int hi, pixelvalue v,
+                     int upper) {
+    int mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (r[mid] < v || (upper && r[mid] == v))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+//! Function implementing rank selection over sorted runs
+/*!
+   Function :   kth_smallest_runs()
+    - In    :   run pointers, run lengths, # of runs, rank k, result
+    - Out   :   0 on success, -1 on bad rank or allocation failure
+*/
+
+int
+#ifdef __GNUC__
+__attribute__((__no_instrument_function__))
+#endif
+kth_smallest_runs(pixelvalue *runs[], int lens[], int nruns, int k,
+                  pixelvalue *kth) {
+    int         *lo, *hi, *lt, *le;
+    run_mid     *mid;
+    int         i, nmid, total, acc, less, leq;
+    int         status = -1;
+    pixelvalue  pivot;
+
+    for (i=0, total=0 ; i<nruns ; i++) total += lens[i];
+    if (k<0 || k>=total) return -1;
+
+    lo  = malloc(4 * nruns * sizeof(int));
+    mid = malloc(nruns * sizeof(run_mid));
+    if (lo==NULL || mid==NULL) {
+        free(mid);
+        free(lo);
+        return -1;
+    }
+    hi = lo + nruns; lt = hi + nruns; le = lt + nruns;
+
+    for (i=0 ; i<nruns ; i++) {
+        lo[i] = 0;
+        hi[i] = lens[i];
+    }
+
+    /* Invariant: 0 <= k < number of active elements */
+    for (;;) {
+        /* Weighted median of the active run middles */
+        nmid = 0; total = 0;
+        for (i=0 ; i<nruns ; i++) {
+            if (hi[i] > lo[i]) {
+                mid[nmid].value  = runs[i][lo[i] + (hi[i] - lo[i]) / 2];
+                mid[nmid].weight = hi[i] - lo[i];
+                total += mid[nmid++].weight;
+            }
+        }
+        if (nmid==0 || k>=total) break;
+        qsort(mid, nmid, sizeof(run_mid), compare_run_mid);
+        for (i=0, acc=0 ; i<nmid ; i++) {
+            acc += mid[i].weight;
+            if (2 * acc >= total) break;
+        }
+        pivot = mid[i].value;
+
+        /* Rank of the pivot among the active elements */
+        less = 0; leq = 0;
+        for (i=0 ; i<nruns ; i++) {
+            lt[i] = run_bound(runs[i], lo[i], hi[i], pivot, 0);
+            le[i] = run_bound(runs[i], lt[i], hi[i], pivot, 1);
+            less += lt[i] - lo[i];
+            leq  += le[i] - lo[i];
+        }
+
+        /* Keep only the side that holds rank k */
+        if (k < less) {
+            for (i=0 ; i<nruns ; i++) hi[i] = lt[i];
+        } else if (k < leq) {
+            *kth = pivot;
+            status = 0;
+            break;
+        } else {
+            for (i=0 ; i<nruns ; i++) lo[i] = le[i];
+            k -= leq;
+        }
+    }
+    free(mid);
+    free(lo);
+    return status;
+}
+
+//! Function wrapper for kth_smallest_runs to get the union's median
+/*!
+   Function :   median_runs()
+    - In    :   run pointers, run lengths, # of runs, result
+    - Out   :   0 on success, -1 if the runs are empty
+*/
+int
+#ifdef __GNUC__
+__attribute__((__no_instrument_function__))
+#endif
+median_runs(pixelvalue *runs[], int lens[], int nruns, pixelvalue *med) {
+    int     i, n = 0;
+
+    for (i=0 ; i<nruns ; i++) n += lens[i];
+    return kth_smallest_runs(runs, lens, nruns, (n-1)/2, med);
+}
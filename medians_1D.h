@@ -79,6 +79,41 @@
 
 /////////////////////////////////////////////////////////////////////////
 
+/*! \fn int kth_smallest_runs(pixelvalue *runs[], int lens[], int nruns, int k, pixelvalue *kth)
+   \brief Rank selection over a union of sorted runs, without merging
+
+   Function  :   kth_smallest_runs()
+    - In     :   array of run pointers, array of run lengths, # of runs,
+                 rank k (0-based over the union of all runs), result
+    - Out    :   0 on success, -1 if k is outside [0, total length) or
+                 the O(K) bookkeeping cannot be allocated
+    - Job    :   find the kth smallest element of the union of the runs
+    - Note   :   each run must be sorted in ascending order; the runs are
+                 read-only and never copied or merged
+
+	Each round picks the weighted median of the middle elements of
+	the active part of every run as a pivot, counts the elements
+	below and at the pivot with a binary search in each run, and
+	discards the side that cannot hold rank k.  At least a quarter
+	of the active elements go each round, so with K runs and N
+	elements in total it needs O(log N) rounds of O(K log N) work,
+	O(K log^2 N) overall.  This is a log N factor above the
+	Frederickson-Johnson bound, traded for a much simpler loop.
+
+ */
+
+/////////////////////////////////////////////////////////////////////////
+
+/*! \fn int median_runs(pixelvalue *runs[], int lens[], int nruns, pixelvalue *med)
+    \brief Median of a union of sorted runs, from kth_smallest_runs().
+
+    Chooses the lower median for an even number of elements, the same
+    as quick_select() on the concatenated runs.  Returns -1 if all the
+    runs are empty.
+*/
+
+/////////////////////////////////////////////////////////////////////////
+
 /*! \fn pixelvalue wirth(pixelvalue a[], int n)
     \brief A function that returns the median from kth_smallest.
    
@@ -107,6 +142,10 @@
 
 typedef float pixelvalue;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void swap(pixelvalue *, pixelvalue *);
 
 pixelvalue quick_select(pixelvalue a[], int n);
@@ -117,6 +156,15 @@ pixelvalue wirth(pixelvalue a[], int n);
 
 pixelvalue torben(pixelvalue a[], int n);
 
+int kth_smallest_runs(pixelvalue *runs[], int lens[], int nruns, int k,
+                      pixelvalue *kth);
+
+int median_runs(pixelvalue *runs[], int lens[], int nruns, pixelvalue *med);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
 
 /***********************************************************************
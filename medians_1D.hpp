@@ -0,0 +1,404 @@
+/*! \file medians_1D.hpp
+   \brief Header-only C++ templates for 1-D median search.
+
+   These are the same algorithms as the C routines in medians_1D.c,
+   written as templates over random-access iterators.  The element
+   type, the comparator and an optional key projection (a callable or
+   a member pointer, applied with std::invoke) are template parameters,
+   so the compiler can inline the comparisons and the element swaps
+   instead of calling through the exported swap().
+   Fixed-size selection networks take the window size as a template
+   argument and are fully unrolled.
+
+   As with the C API, quick_select(), kth_smallest(), wirth() and the
+   fixed networks reorder their input in place; torben() is read-only.
+   With C++20 every routine is also available on std::span.
+
+   Original algorithms by Nicolas Devillard (quickselect, Wirth),
+   Torben Mogensen and N. Devillard (Torben).
+   Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+   This code is licensed under the LGPLv3.  See the LICENSE file for
+   details.
+ */
+
+#ifndef _MEDIANS_1D_HPP_
+#define _MEDIANS_1D_HPP_
+
+#if __cplusplus < 201703L
+#error "medians_1D.hpp requires C++17"
+#endif
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#define MEDIANS_1D_HAVE_SPAN 1
+#endif
+#endif
+
+namespace medians_1D {
+
+//! Default key projection: the element itself
+struct identity {
+    template <class T>
+    constexpr T &&operator()(T &&t) const noexcept {
+        return std::forward<T>(t);
+    }
+};
+
+namespace detail {
+
+//! Strict weak ordering on projected keys
+template <class Compare, class Proj>
+struct projected_less {
+    Compare comp;
+    Proj    proj;
+
+    template <class A, class B>
+    constexpr bool operator()(const A &a, const B &b) const {
+        return comp(std::invoke(proj, a), std::invoke(proj, b));
+    }
+};
+
+template <class Compare, class Proj>
+constexpr projected_less<Compare, Proj> make_less(Compare comp, Proj proj) {
+    return projected_less<Compare, Proj>{comp, proj};
+}
+
+//! Compare-exchange: afterwards !less(b, a)
+template <class T, class Less>
+constexpr void sort2(T &a, T &b, const Less &less) {
+    if (less(b, a)) {
+        using std::swap;
+        swap(a, b);
+    }
+}
+
+//! One round of odd-even transposition, unrolled over the pair indices
+template <std::size_t Start, class RandomIt, class Less, std::size_t... P>
+constexpr void oet_round(RandomIt p, const Less &less,
+                         std::index_sequence<P...>) {
+    (sort2(p[Start + 2*P], p[Start + 2*P + 1], less), ...);
+}
+
+//! N rounds of odd-even transposition sort N elements
+template <std::size_t N, class RandomIt, class Less, std::size_t... R>
+constexpr void oet_sort(RandomIt p, const Less &less,
+                        std::index_sequence<R...>) {
+    (((R & 1)
+        ? oet_round<1>(p, less, std::make_index_sequence<(N-1)/2>{})
+        : oet_round<0>(p, less, std::make_index_sequence<N/2>{})), ...);
+}
+
+//! Generic fixed-size network; specialized below for the common sizes
+template <std::size_t N>
+struct network {
+    template <class RandomIt, class Less>
+    static constexpr void run(RandomIt p, const Less &less) {
+        oet_sort<N>(p, less, std::make_index_sequence<N>{});
+    }
+};
+
+template <>
+struct network<1> {
+    template <class RandomIt, class Less>
+    static constexpr void run(RandomIt, const Less &) {}
+};
+
+template <>
+struct network<2> {
+    template <class RandomIt, class Less>
+    static constexpr void run(RandomIt p, const Less &less) {
+        sort2(p[0], p[1], less);
+    }
+};
+
+template <>
+struct network<3> {
+    template <class RandomIt, class Less>
+    static constexpr void run(RandomIt p, const Less &less) {
+        sort2(p[0], p[1], less); sort2(p[1], p[2], less);
+        sort2(p[0], p[1], less);
+    }
+};
+
+template <>
+struct network<5> {
+    template <class RandomIt, class Less>
+    static constexpr void run(RandomIt p, const Less &less) {
+        sort2(p[0], p[1], less); sort2(p[3], p[4], less);
+        sort2(p[0], p[3], less); sort2(p[1], p[4], less);
+        sort2(p[1], p[2], less); sort2(p[2], p[3], less);
+        sort2(p[1], p[2], less);
+    }
+};
+
+template <>
+struct network<7> {
+    template <class RandomIt, class Less>
+    static constexpr void run(RandomIt p, const Less &less) {
+        sort2(p[0], p[5], less); sort2(p[0], p[3], less);
+        sort2(p[1], p[6], less); sort2(p[2], p[4], less);
+        sort2(p[0], p[1], less); sort2(p[3], p[5], less);
+        sort2(p[2], p[6], less); sort2(p[2], p[3], less);
+        sort2(p[3], p[6], less); sort2(p[4], p[5], less);
+        sort2(p[1], p[4], less); sort2(p[1], p[3], less);
+        sort2(p[3], p[4], less);
+    }
+};
+
+template <>
+struct network<9> {
+    template <class RandomIt, class Less>
+    static constexpr void run(RandomIt p, const Less &less) {
+        sort2(p[1], p[2], less); sort2(p[4], p[5], less);
+        sort2(p[7], p[8], less); sort2(p[0], p[1], less);
+        sort2(p[3], p[4], less); sort2(p[6], p[7], less);
+        sort2(p[1], p[2], less); sort2(p[4], p[5], less);
+        sort2(p[7], p[8], less); sort2(p[0], p[3], less);
+        sort2(p[5], p[8], less); sort2(p[4], p[7], less);
+        sort2(p[3], p[6], less); sort2(p[1], p[4], less);
+        sort2(p[2], p[5], less); sort2(p[4], p[7], less);
+        sort2(p[4], p[2], less); sort2(p[6], p[4], less);
+        sort2(p[4], p[2], less);
+    }
+};
+
+template <class RandomIt>
+using value_t = typename std::iterator_traits<RandomIt>::value_type;
+
+template <class RandomIt, class Proj>
+using key_t = std::decay_t<std::invoke_result_t<const Proj &,
+                  typename std::iterator_traits<RandomIt>::reference>>;
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////
+
+/*! \fn quick_select(RandomIt, RandomIt, Compare, Proj)
+   \brief Quickselect algorithm from Numerical Recipes
+
+    - In     :   iterator range, comparator, key projection
+    - Out    :   one element
+    - Job    :   find the median element in the range
+    - Note   :   chooses the lower median for an even number of elements
+ */
+template <class RandomIt, class Compare = std::less<>, class Proj = identity>
+detail::value_t<RandomIt>
+quick_select(RandomIt a, RandomIt last, Compare comp = {}, Proj proj = {}) {
+    using diff_t = typename std::iterator_traits<RandomIt>::difference_type;
+    const auto less = detail::make_less(comp, proj);
+    diff_t  low, high, median, middle, ll, hh;
+
+    low = 0 ; high = (last - a) - 1 ; median = (low + high) / 2;
+    for (;;) {
+        if (high <= low) /* One element only */
+            return a[median];
+
+        if (high == low + 1) {  /* Two elements only */
+            detail::sort2(a[low], a[high], less);
+            return a[median];
+        }
+
+        /* Find median of low, middle and high items; swap into position low */
+        middle = (low + high) / 2;
+        detail::sort2(a[middle], a[high], less);
+        detail::sort2(a[low], a[high], less);
+        detail::sort2(a[middle], a[low], less);
+
+        /* Swap low item (now in position middle) into position (low+1) */
+        std::iter_swap(a + middle, a + (low + 1));
+
+        /* Nibble from each end towards middle, swapping items when stuck */
+        ll = low + 1;
+        hh = high;
+        for (;;) {
+            do ll++; while (less(a[ll], a[low]));
+            do hh--; while (less(a[low], a[hh]));
+
+            if (hh < ll)
+                break;
+
+            std::iter_swap(a + ll, a + hh);
+        }
+
+        /* Swap middle item (in position low) back into correct position */
+        std::iter_swap(a + low, a + hh);
+
+        /* Re-set active partition */
+        if (hh <= median)
+            low = ll;
+        if (hh >= median)
+            high = hh - 1;
+    }
+}
+
+/*! \fn kth_smallest(RandomIt, RandomIt, difference_type, Compare, Proj)
+   \brief Wirth's rank-order selection
+
+    - In     :   iterator range, rank k (0-based), comparator, projection
+    - Out    :   one element
+    - Job    :   find the kth smallest element in the range
+ */
+template <class RandomIt, class Compare = std::less<>, class Proj = identity>
+detail::value_t<RandomIt>
+kth_smallest(RandomIt a, RandomIt last,
+             typename std::iterator_traits<RandomIt>::difference_type k,
+             Compare comp = {}, Proj proj = {}) {
+    using diff_t = typename std::iterator_traits<RandomIt>::difference_type;
+    const auto less = detail::make_less(comp, proj);
+    diff_t  i, j, l, m;
+
+    l = 0 ; m = (last - a) - 1;
+    while (l < m) {
+        const detail::value_t<RandomIt> x = a[k];
+        i = l;
+        j = m;
+        do {
+            while (less(a[i], x)) i++;
+            while (less(x, a[j])) j--;
+            if (i <= j) {
+                std::iter_swap(a + i, a + j);
+                i++ ; j--;
+            }
+        } while (i <= j);
+        if (j < k) l = i;
+        if (k < i) m = j;
+    }
+    return a[k];
+}
+
+/*! \fn wirth(RandomIt, RandomIt, Compare, Proj)
+    \brief Lower median from kth_smallest(), same as the C wirth()
+*/
+template <class RandomIt, class Compare = std::less<>, class Proj = identity>
+detail::value_t<RandomIt>
+wirth(RandomIt a, RandomIt last, Compare comp = {}, Proj proj = {}) {
+    const auto n = last - a;
+    return kth_smallest(a, last, (n & 1) ? n/2 : n/2 - 1, comp, proj);
+}
+
+/*! \fn torben(RandomIt, RandomIt, Proj)
+   \brief Torben's algorithm for large read-only data sets
+
+    - In     :   iterator range, key projection
+    - Out    :   median key
+    - Job    :   find the median key without modifying the range
+    - Note   :   keys must support +, / 2 and <, as in the C version
+ */
+template <class RandomIt, class Proj = identity>
+detail::key_t<RandomIt, Proj>
+torben(RandomIt m, RandomIt last, Proj proj = {}) {
+    using key    = detail::key_t<RandomIt, Proj>;
+    using diff_t = typename std::iterator_traits<RandomIt>::difference_type;
+    const diff_t n = last - m;
+    diff_t  i, less, greater, equal, half;
+    key     min, max, guess, maxltguess, mingtguess;
+
+    half = (n+1)/2;
+    min = max = std::invoke(proj, m[0]);
+    for (i=1 ; i<n ; i++) {
+        const key v = std::invoke(proj, m[i]);
+        if (v<min) min=v;
+        if (v>max) max=v;
+    }
+
+    while (1) {
+        guess = (min+max)/2;
+        less = 0; greater = 0; equal = 0;
+        maxltguess = min;
+        mingtguess = max;
+        for (i=0; i<n; i++) {
+            const key v = std::invoke(proj, m[i]);
+            if (v<guess) {
+                less++;
+                if (v>maxltguess) maxltguess = v;
+            } else if (v>guess) {
+                greater++;
+                if (v<mingtguess) mingtguess = v;
+            } else equal++;
+        }
+        if (less <= half && greater <= half) break;
+        else if (less>greater) max = maxltguess;
+        else min = mingtguess;
+    }
+    if (less >= half) return maxltguess;
+    else if (less+equal >= half) return guess;
+    else return mingtguess;
+}
+
+/*! \fn median_fixed<N>(RandomIt, Compare, Proj)
+   \brief Fully unrolled median of exactly N elements
+
+    - In     :   iterator to N elements, comparator, key projection
+    - Out    :   one element (lower median for even N)
+    - Note   :   optimal networks for N = 3, 5, 7, 9; other sizes use an
+                 unrolled odd-even transposition network
+ */
+template <std::size_t N, class RandomIt, class Compare = std::less<>,
+          class Proj = identity>
+constexpr detail::value_t<RandomIt>
+median_fixed(RandomIt p, Compare comp = {}, Proj proj = {}) {
+    static_assert(N > 0, "median of an empty window");
+    detail::network<N>::run(p, detail::make_less(comp, proj));
+    return p[(N-1)/2];
+}
+
+//! median_fixed() on a std::array; the size is deduced
+template <class T, std::size_t N, class Compare = std::less<>,
+          class Proj = identity>
+constexpr T median_fixed(std::array<T, N> &a, Compare comp = {},
+                         Proj proj = {}) {
+    return median_fixed<N>(a.begin(), comp, proj);
+}
+
+#ifdef MEDIANS_1D_HAVE_SPAN
+
+//! quick_select() over a std::span, without copying
+template <class T, std::size_t E, class Compare = std::less<>,
+          class Proj = identity>
+T quick_select(std::span<T, E> s, Compare comp = {}, Proj proj = {}) {
+    return quick_select(s.begin(), s.end(), comp, proj);
+}
+
+//! kth_smallest() over a std::span, without copying
+template <class T, std::size_t E, class Compare = std::less<>,
+          class Proj = identity>
+T kth_smallest(std::span<T, E> s, std::ptrdiff_t k, Compare comp = {},
+               Proj proj = {}) {
+    return kth_smallest(s.begin(), s.end(), k, comp, proj);
+}
+
+//! wirth() over a std::span, without copying
+template <class T, std::size_t E, class Compare = std::less<>,
+          class Proj = identity>
+T wirth(std::span<T, E> s, Compare comp = {}, Proj proj = {}) {
+    return wirth(s.begin(), s.end(), comp, proj);
+}
+
+//! torben() over a read-only std::span
+template <class T, std::size_t E, class Proj = identity>
+auto torben(std::span<T, E> s, Proj proj = {}) {
+    return torben(s.begin(), s.end(), proj);
+}
+
+//! median_fixed() on a span with static extent; the size is deduced
+template <class T, std::size_t N, class Compare = std::less<>,
+          class Proj = identity>
+    requires (N != std::dynamic_extent)
+constexpr T median_fixed(std::span<T, N> s, Compare comp = {},
+                         Proj proj = {}) {
+    return median_fixed<N>(s.begin(), comp, proj);
+}
+
+#endif
+
+} // namespace medians_1D
+
+#endif
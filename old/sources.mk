@@ -1,7 +1,17 @@
 FULL_SOURCES	= \
 				demo.c \
 				medians_1D.c \
-				medians_1D.h
+				medians_1D.h \
+				medians_1D.hpp \
+				demo_hpp.cpp \
+				median_service.c \
+				median_service.h \
+				service_demo.c \
+				median_partition.c \
+				median_partition.h \
+				partition_demo.c \
+				median_ostat.c \
+				median_ostat.h
 
 SWIG_SOURCES	= \
 				old/medians_1D.i
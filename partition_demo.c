@@ -0,0 +1,269 @@
+/*! \file partition_demo.c
+   \brief Multi-process harness for the partitioned median protocol.
+
+   The data is split into one shard per worker process; each worker is
+   forked with its shard and talks to the coordinator over a pair of
+   pipes.  The coordinator sends a summary query, then one pivot query
+   per round, and merges the fixed-size replies.  The result and the
+   elapsed wall time are compared with torben() and quick_select() on
+   the whole array in a single process.
+
+   Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+   This code is licensed under the LGPLv3.  See the LICENSE file for
+   details.
+*/
+
+#include "median_partition.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <float.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+//! Number of elements in the target array
+#define BIG_NUM (1024*1024)
+
+//! Random test data; generated values are in [0...MAX_ARRAY_VALUE-1]
+#define MAX_ARRAY_VALUE     1024
+
+//! Coordinator to shard query
+typedef struct part_query {
+    int         op;
+    pixelvalue  guess;
+} part_query;
+
+//! Query operations
+enum { OP_SUMMARY = 0, OP_COUNT, OP_QUIT };
+
+//! Coordinator end of one worker's pipes
+typedef struct worker {
+    pid_t   pid;
+    int     to;
+    int     from;
+} worker;
+
+// Additional required function prototypes
+double wall_time(void);
+int xfer(int, void *, size_t, int);
+void serve(const pixelvalue *, int, int, int);
+int coordinate(worker *, int, pixelvalue *, int *, size_t *);
+void reap(worker *, int, int);
+
+//! Wall-clock time in seconds; clock() would only see the coordinator
+double wall_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//! Read or write exactly len bytes on a pipe; 0 on success
+int xfer(int fd, void *buf, size_t len, int writing)
+{
+    char *  p = buf;
+    ssize_t got;
+
+    while (len > 0) {
+        got = writing ? write(fd, p, len) : read(fd, p, len);
+        if (got <= 0) return -1;
+        p += got;
+        len -= got;
+    }
+    return 0;
+}
+
+//! Worker process: answer queries on the local shard until told to quit
+void serve(const pixelvalue *shard, int n, int in, int out)
+{
+    part_query      q;
+    part_summary    s;
+    part_counts     c;
+
+    while (xfer(in, &q, sizeof(q), 0) == 0) {
+        if (q.op == OP_SUMMARY) {
+            part_summarize(shard, n, &s);
+            if (xfer(out, &s, sizeof(s), 1) != 0) break;
+        } else if (q.op == OP_COUNT) {
+            part_count(shard, n, q.guess, &c);
+            if (xfer(out, &c, sizeof(c), 1) != 0) break;
+        } else {
+            break;
+        }
+    }
+}
+
+//! Coordinator: run the protocol over all workers; -1 on failure or no data
+int coordinate(worker *w, int nworkers, pixelvalue *med, int *rounds,
+               size_t *bytes)
+{
+    part_query      q;
+    part_summary    s, all;
+    part_counts     c, acc;
+    part_coord      pc;
+    int             i;
+
+    *bytes = 0;
+    q.op = OP_SUMMARY;
+    q.guess = 0;
+    part_summarize(NULL, 0, &all);
+    for (i=0 ; i<nworkers ; i++) {
+        if (xfer(w[i].to, &q, sizeof(q), 1) != 0) return -1;
+    }
+    for (i=0 ; i<nworkers ; i++) {
+        if (xfer(w[i].from, &s, sizeof(s), 0) != 0) return -1;
+        part_merge_summary(&all, &s);
+    }
+    *bytes += nworkers * (sizeof(q) + sizeof(s));
+    if (all.n<1) return -1;
+    part_coord_init(&pc, &all);
+
+    while (!pc.done) {
+        q.op = OP_COUNT;
+        q.guess = part_coord_guess(&pc);
+        for (i=0 ; i<nworkers ; i++) {
+            if (xfer(w[i].to, &q, sizeof(q), 1) != 0) return -1;
+        }
+        part_counts_init(&acc);
+        for (i=0 ; i<nworkers ; i++) {
+            if (xfer(w[i].from, &c, sizeof(c), 0) != 0) return -1;
+            part_merge_counts(&acc, &c);
+        }
+        *bytes += nworkers * (sizeof(q) + sizeof(c));
+        part_coord_update(&pc, &acc);
+    }
+    *rounds = pc.rounds;
+    *med = pc.median;
+    return 0;
+}
+
+//! Stop all workers (politely, or with SIGTERM) and wait for them
+void reap(worker *w, int nworkers, int force)
+{
+    part_query  quit;
+    int         i;
+
+    quit.op = OP_QUIT;
+    quit.guess = 0;
+    for (i=0 ; i<nworkers ; i++) {
+        if (force) kill(w[i].pid, SIGTERM);
+        else xfer(w[i].to, &quit, sizeof(quit), 1);
+        close(w[i].to);
+        close(w[i].from);
+    }
+    for (i=0 ; i<nworkers ; i++)
+        waitpid(w[i].pid, NULL, 0);
+}
+
+//! Main driver for the partitioned median harness
+int main(int argc, char * argv[])
+{
+    int             nworkers, i, j, rounds, len, off;
+    size_t          array_size, bytes;
+    pixelvalue  *   array;
+    pixelvalue      med[3];
+    worker      *   w;
+    int             down[2], up[2];
+    double          t0, elapsed;
+
+    if (argc<2) {
+        printf("usage:\n");
+        printf("%s <workers> [n]\n", argv[0]);
+        printf("\tfork <workers> shard processes over n elements (default\n");
+        printf("\t%d) and find the exact median over pipes\n", BIG_NUM);
+        printf("\n");
+        exit(EXIT_FAILURE);
+    }
+    nworkers   = atoi(argv[1]);
+    array_size = (argc>2) ? (size_t)atol(argv[2]) : BIG_NUM;
+    if (nworkers<1 || array_size<1) {
+        printf("need at least one worker and one element\n");
+        exit(EXIT_FAILURE);
+    }
+
+    array = malloc(array_size * sizeof(pixelvalue));
+    w     = malloc(nworkers * sizeof(worker));
+    if (array==NULL || w==NULL) {
+        printf("memory allocation failure: aborting\n");
+        exit(EXIT_FAILURE);
+    }
+    srand48(getpid());
+    for (i=0 ; i<array_size ; i++) {
+        array[i] = (pixelvalue)(lrand48() % MAX_ARRAY_VALUE);
+    }
+
+    /* Each child keeps only its own slice of the copy-on-write array */
+    for (i=0, off=0 ; i<nworkers ; i++, off+=len) {
+        len = array_size / nworkers + ((size_t)i < array_size % nworkers);
+        if (pipe(down)!=0 || pipe(up)!=0) {
+            printf("pipe failure: aborting\n");
+            reap(w, i, 1);
+            exit(EXIT_FAILURE);
+        }
+        fflush(stdout);
+        w[i].pid = fork();
+        if (w[i].pid < 0) {
+            printf("fork failure: aborting\n");
+            reap(w, i, 1);
+            exit(EXIT_FAILURE);
+        }
+        if (w[i].pid == 0) {
+            for (j=0 ; j<i ; j++) {
+                close(w[j].to);
+                close(w[j].from);
+            }
+            close(down[1]);
+            close(up[0]);
+            serve(array + off, len, down[0], up[1]);
+            _exit(EXIT_SUCCESS);
+        }
+        close(down[0]);
+        close(up[1]);
+        w[i].to   = down[1];
+        w[i].from = up[0];
+    }
+
+    printf("array size: %ld in %d worker processes\n",
+           (long)array_size, nworkers);
+
+    /* a dead worker must not turn into EPIPE-killing the coordinator */
+    signal(SIGPIPE, SIG_IGN);
+
+    t0 = wall_time();
+    if (coordinate(w, nworkers, &med[0], &rounds, &bytes) != 0) {
+        printf("worker failure: aborting\n");
+        reap(w, nworkers, 1);
+        exit(EXIT_FAILURE);
+    }
+    elapsed = wall_time() - t0;
+    printf("partitioned     :\t%5.3f sec\tmed %g\t%d rounds, %lu bytes\n",
+           elapsed, (double)med[0], rounds, (unsigned long)bytes);
+
+    reap(w, nworkers, 0);
+
+    t0 = wall_time();
+    med[1] = torben(array, array_size);
+    elapsed = wall_time() - t0;
+    printf("torben          :\t%5.3f sec\tmed %g\n", elapsed, (double)med[1]);
+
+    t0 = wall_time();
+    med[2] = quick_select(array, array_size);
+    elapsed = wall_time() - t0;
+    printf("quick select    :\t%5.3f sec\tmed %g\n", elapsed, (double)med[2]);
+
+    for (i=1 ; i<3 ; i++) {
+        if (fabs(med[i-1] - med[i]) > 10 * FLT_EPSILON) {
+            printf("diverging median values!\n");
+        }
+    }
+
+    free(w);
+    free(array);
+    return EXIT_SUCCESS;
+}
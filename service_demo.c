@@ -0,0 +1,226 @@
+/*! \file service_demo.c
+   \brief Load generator for the concurrent median service.
+
+   A number of producer threads push random samples at a fixed rate to
+   random channels while a reader polls every channel.  Every newly
+   published window contributes one sample to each of three latencies:
+   window close to publish (the service's own selection overhead),
+   ingestion of the oldest sample to publish, and ingestion of the
+   oldest sample to the reader first seeing the median.  The reader
+   polls much faster than the window period so that its own delay
+   stays small.  Percentiles are reported at the end.
+
+   Stephen Arnold <stephen.arnold42 _at_ gmail.com>
+   This code is licensed under the LGPLv3.  See the LICENSE file for
+   details.
+*/
+
+#include "median_service.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+//! Random test data; generated values are in [0...MAX_ARRAY_VALUE-1]
+#define MAX_ARRAY_VALUE     1024
+
+//! Window period in microseconds
+#define PERIOD_US           10000
+
+//! Reader poll interval in microseconds
+#define POLL_US             200
+
+//! Ring slots per channel
+#define RING_SIZE           (1<<14)
+
+//! Samples pushed between rate checks
+#define PUSH_BATCH          64
+
+// Additional required function prototypes
+void *producer(void *);
+int compare_u64(const void *, const void *);
+void report(const char *, uint64_t *, size_t);
+
+//! Shared load generator settings
+typedef struct load_cfg {
+    median_service *svc;
+    int             channels;
+    long            rate;
+    atomic_int      running;
+    atomic_ulong    pushed;
+} load_cfg;
+
+//! Producer thread: push random samples at cfg->rate samples per second
+void *producer(void *arg)
+{
+    load_cfg *      cfg = arg;
+    unsigned short  xsubi[3];
+    uint64_t        start, due, now;
+    unsigned long   n = 0;
+    int             i;
+    struct timespec ts;
+
+    xsubi[0] = (unsigned short)getpid();
+    xsubi[1] = (unsigned short)(uintptr_t)&n;
+    xsubi[2] = (unsigned short)ms_now_ns();
+
+    start = ms_now_ns();
+    while (atomic_load(&cfg->running)) {
+        for (i=0 ; i<PUSH_BATCH ; i++) {
+            ms_push(cfg->svc, (int)(nrand48(xsubi) % cfg->channels),
+                    (pixelvalue)(nrand48(xsubi) % MAX_ARRAY_VALUE));
+        }
+        n += PUSH_BATCH;
+        due = start + (uint64_t)(n * 1e9 / cfg->rate);
+        now = ms_now_ns();
+        if (due > now + 1000) {
+            ts.tv_sec  = (time_t)((due - now) / 1000000000u);
+            ts.tv_nsec = (long)((due - now) % 1000000000u);
+            nanosleep(&ts, NULL);
+        }
+    }
+    atomic_fetch_add(&cfg->pushed, n);
+    return NULL;
+}
+
+//! This function is only useful to the qsort() routine
+int compare_u64(const void *f1, const void *f2)
+{
+    uint64_t a = *(const uint64_t *)f1, b = *(const uint64_t *)f2;
+    return (a > b) - (a < b);
+}
+
+//! Print latency percentiles in microseconds
+void report(const char *what, uint64_t *lat, size_t n)
+{
+    static const double pct[] = { 50.0, 90.0, 99.0, 99.9 };
+    size_t  i, idx;
+
+    if (n==0) {
+        printf("no windows published\n");
+        return;
+    }
+    qsort(lat, n, sizeof(uint64_t), compare_u64);
+    printf("%s:\n", what);
+    for (i=0 ; i<sizeof(pct)/sizeof(pct[0]) ; i++) {
+        idx = (size_t)(pct[i] / 100.0 * (n - 1) + 0.5);
+        printf("  p%-5g latency:\t%8.1f usec\n", pct[i], lat[idx] / 1e3);
+    }
+    printf("  max latency   :\t%8.1f usec\n", lat[n-1] / 1e3);
+}
+
+//! Main driver for the median service load generator
+int main(int argc, char * argv[])
+{
+    int             producers, channels, workers, seconds;
+    int             i, c;
+    pthread_t *     threads;
+    unsigned long * seen;
+    uint64_t *      lat;
+    uint64_t *      pub;
+    uint64_t *      sel;
+    size_t          nlat = 0, maxlat;
+    uint64_t        stop;
+    unsigned long   dropped = 0;
+    ms_result       res;
+    load_cfg        cfg;
+    struct timespec ts;
+
+    if (argc<2) {
+        printf("usage:\n");
+        printf("%s <producers> [channels] [workers] [seconds] [rate]\n", argv[0]);
+        printf("\tpush <rate> samples/sec from each producer thread into\n");
+        printf("\t<channels> channels and report end-to-end latency of\n");
+        printf("\tthe %d msec window medians\n", PERIOD_US / 1000);
+        printf("\n");
+        exit(EXIT_FAILURE);
+    }
+
+    producers = atoi(argv[1]);
+    channels  = (argc>2) ? atoi(argv[2]) : 8;
+    workers   = (argc>3) ? atoi(argv[3]) : 2;
+    seconds   = (argc>4) ? atoi(argv[4]) : 2;
+    cfg.rate  = (argc>5) ? atol(argv[5]) : 200000;
+    if (producers<1 || channels<1 || workers<1 || seconds<1 || cfg.rate<1) {
+        printf("all arguments must be positive\n");
+        exit(EXIT_FAILURE);
+    }
+
+    cfg.channels = channels;
+    cfg.svc = ms_create(channels, RING_SIZE, RING_SIZE * 4, workers, PERIOD_US);
+    threads = malloc(producers * sizeof(pthread_t));
+    seen    = calloc(channels, sizeof(unsigned long));
+    maxlat  = (size_t)channels * (seconds * (1000000 / PERIOD_US) + 2);
+    lat     = malloc(maxlat * sizeof(uint64_t));
+    pub     = malloc(maxlat * sizeof(uint64_t));
+    sel     = malloc(maxlat * sizeof(uint64_t));
+    if (cfg.svc==NULL || threads==NULL || seen==NULL || lat==NULL
+        || pub==NULL || sel==NULL) {
+        printf("memory allocation failure: aborting\n");
+        exit(EXIT_FAILURE);
+    }
+    atomic_init(&cfg.running, 1);
+    atomic_init(&cfg.pushed, 0);
+
+    printf("producers: %d  channels: %d  workers: %d  rate: %ld/sec each\n",
+           producers, channels, workers, cfg.rate);
+    fflush(stdout);
+
+    if (ms_start(cfg.svc) != 0) {
+        printf("could not start median service: aborting\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i=0 ; i<producers ; i++) {
+        if (pthread_create(&threads[i], NULL, producer, &cfg) != 0) {
+            printf("could not start producer %d: aborting\n", i);
+            atomic_store(&cfg.running, 0);
+            while (i-- > 0)
+                pthread_join(threads[i], NULL);
+            ms_stop(cfg.svc);
+            ms_destroy(cfg.svc);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ts.tv_sec = 0;
+    ts.tv_nsec = POLL_US * 1000L;
+    stop = ms_now_ns() + (uint64_t)seconds * 1000000000u;
+    while (ms_now_ns() < stop) {
+        nanosleep(&ts, NULL);
+        for (c=0 ; c<channels ; c++) {
+            if (ms_read(cfg.svc, c, &res) != 0 || res.window==seen[c])
+                continue;
+            seen[c] = res.window;
+            if (nlat < maxlat) {
+                sel[nlat] = res.publish_ns - res.close_ns;
+                pub[nlat] = res.publish_ns - res.first_ns;
+                lat[nlat++] = ms_now_ns() - res.first_ns;
+            }
+        }
+    }
+
+    atomic_store(&cfg.running, 0);
+    for (i=0 ; i<producers ; i++)
+        pthread_join(threads[i], NULL);
+    ms_stop(cfg.svc);
+
+    for (c=0 ; c<channels ; c++)
+        dropped += ms_dropped(cfg.svc, c);
+    printf("samples pushed  :\t%lu\n", atomic_load(&cfg.pushed));
+    printf("samples dropped :\t%lu\n", dropped);
+    printf("windows         :\t%lu\n", (unsigned long)nlat);
+    report("window close to publish", sel, nlat);
+    report("ingest to publish", pub, nlat);
+    report("ingest to reader", lat, nlat);
+
+    ms_destroy(cfg.svc);
+    free(sel);
+    free(pub);
+    free(lat);
+    free(seen);
+    free(threads);
+    return EXIT_SUCCESS;
+}